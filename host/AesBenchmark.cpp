@@ -0,0 +1,196 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Checks an os_aes() implementation against the FIPS-197, SP 800-38A and
+// RFC 4493 test vectors and measures how many LoRaWAN frames per second it
+// encrypts and authenticates. Build it once per implementation, from the
+// repository root:
+//
+//   g++ -O2 -Ihost -Isrc/aes -DSIMPLE_LORAWAN_AES_BACKEND=1 host/AesBenchmark.cpp
+//       src/aes/AesBackend.cpp src/aes/SoftwareAes.cpp -o aes-software
+//
+//   g++ -O2 -Ihost -Isrc/aes host/AesBenchmark.cpp -x c++ <LMiC>/aes.cpp -o aes-lmic
+//
+// where <LMiC> is a checkout of the library referenced by src/LMiC.lib.
+
+#include "lmic.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const uint8_t FIPS_KEY[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static const uint8_t FIPS_PLAIN[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+static const uint8_t FIPS_CIPHER[16] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+// SP 800-38A and RFC 4493 share the key and the four plaintext blocks
+static const uint8_t KEY[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static const uint8_t PLAIN[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+
+// F.1.1 ECB-AES128.Encrypt
+static const uint8_t ECB_CIPHER[64] = {
+    0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60, 0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+    0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d, 0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+    0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23, 0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+    0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f, 0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4
+};
+
+// F.5.1 CTR-AES128.Encrypt, counter blocks f0f1...feff, ...ff00, ...ff01, ...ff02
+static const uint8_t CTR_CIPHER[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee
+};
+
+// RFC 4493 examples 2 to 4, the first four bytes as os_aes() returns them.
+// Example 1 is the empty message, which LoRaWAN never authenticates and
+// LMiC's os_aes() does not process.
+static const int CMAC_LENGTHS[3] = { 16, 40, 64 };
+static const u4_t CMAC_TAGS[3] = { 0x070a16b4, 0xdfa66747, 0x51f0bebf };
+
+static int failures = 0;
+
+static void check(const char* name, bool passed)
+{
+    printf("%-36s %s\n", name, passed ? "ok" : "FAILED");
+    if(!passed) {
+        failures++;
+    }
+}
+
+// LMiC expands the key in place in AESKEY, so lmic.c copies the session key
+// into AESkey before every os_aes() call and so does this program
+static void setKey(const uint8_t key[16])
+{
+    memcpy(AESkey, key, 16);
+}
+
+static void checkVectors()
+{
+    uint8_t buffer[64];
+    char name[40];
+
+    setKey(FIPS_KEY);
+    memcpy(buffer, FIPS_PLAIN, 16);
+    os_aes(AES_ENC, buffer, 16);
+    check("FIPS-197 C.1", memcmp(buffer, FIPS_CIPHER, 16) == 0);
+
+    setKey(KEY);
+    memcpy(buffer, PLAIN, 64);
+    os_aes(AES_ENC, buffer, 64);
+    check("SP 800-38A F.1.1 ECB", memcmp(buffer, ECB_CIPHER, 64) == 0);
+
+    // LoRaWAN counters never carry out of the last byte, so every block of
+    // F.5.1 is checked with its own counter block
+    for(int block = 0; block < 4; block++) {
+        for(int i = 0; i < 16; i++) {
+            AESaux[i] = 0xf0 + i;
+        }
+        AESaux[14] += (block > 0);
+        AESaux[15] += block;
+        memcpy(buffer, PLAIN + 16 * block, 16);
+        setKey(KEY);
+        os_aes(AES_CTR, buffer, 16);
+        snprintf(name, sizeof(name), "SP 800-38A F.5.1 CTR block %d", block + 1);
+        check(name, memcmp(buffer, CTR_CIPHER + 16 * block, 16) == 0);
+    }
+
+    for(int i = 0; i < 3; i++) {
+        memcpy(buffer, PLAIN, 64);
+        setKey(KEY);
+        u4_t tag = os_aes(AES_MIC | AES_MICNOAUX, buffer, CMAC_LENGTHS[i]);
+        snprintf(name, sizeof(name), "RFC 4493 example %d", i + 2);
+        check(name, tag == CMAC_TAGS[i]);
+    }
+
+    // the B0 block in AESaux is the first block of the message
+    memcpy(AESaux, PLAIN, 16);
+    memcpy(buffer, PLAIN + 16, 48);
+    setKey(KEY);
+    check("RFC 4493 example 4, B0 in AESaux", os_aes(AES_MIC, buffer, 48) == CMAC_TAGS[2]);
+}
+
+// A 51 byte uplink as LMiC builds it: the payload is encrypted with the
+// AppSKey, then the MIC is computed over B0 and the 64 byte frame with the
+// NwkSKey, so every frame switches keys twice
+static void benchmark(int frames)
+{
+    uint8_t frame[64];
+    uint8_t appSKey[16];
+    uint8_t nwkSKey[16];
+    u4_t sum = 0;
+
+    memset(frame, 0x5a, sizeof(frame));
+    memcpy(appSKey, KEY, 16);
+    memcpy(nwkSKey, FIPS_KEY, 16);
+
+    clock_t start = clock();
+    for(int i = 0; i < frames; i++) {
+        setKey(appSKey);
+        memset(AESaux, 0, 16);
+        AESaux[0] = 0x01;
+        AESaux[15] = 0x01;
+        os_aes(AES_CTR, frame + 13, 51);
+
+        setKey(nwkSKey);
+        memset(AESaux, 0, 16);
+        AESaux[0] = 0x49;
+        AESaux[15] = 64;
+        sum += os_aes(AES_MIC, frame, 64);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("encrypt + MIC  %10.0f frames/s   (%08x)\n", frames / seconds, (unsigned)sum);
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 200000;
+    if(argc > 1) {
+        sscanf(argv[1], "%d", &frames);
+    }
+
+    checkVectors();
+    if(failures != 0) {
+        printf("%d test vectors failed\n", failures);
+        return 1;
+    }
+    benchmark(frames);
+    return 0;
+}
@@ -0,0 +1,64 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIMPLE_LORAWAN_HOST_OSLMIC_H_
+#define SIMPLE_LORAWAN_HOST_OSLMIC_H_
+
+// The part of LMiC's oslmic.h that aes.cpp and aes/AesBackend.cpp need,
+// so both build on a PC for AesBenchmark.cpp
+
+#include <stdint.h>
+
+typedef uint8_t  bit_t;
+typedef uint8_t  u1_t;
+typedef int8_t   s1_t;
+typedef uint16_t u2_t;
+typedef int16_t  s2_t;
+typedef uint32_t u4_t;
+typedef int32_t  s4_t;
+typedef u1_t*    xref2u1_t;
+typedef const u1_t* xref2cu1_t;
+
+#define CONST_TABLE(type, name) const type name
+#define TABLE_GET_U1(table, index) ((u1_t)(table)[index])
+#define TABLE_GET_U2(table, index) ((u2_t)(table)[index])
+#define TABLE_GET_U4(table, index) ((u4_t)(table)[index])
+#define TABLE_GET_S1(table, index) ((s1_t)(table)[index])
+
+#define ASSERT(cond)
+
+#define AES_ENC       0x00
+#define AES_DEC       0x80
+#define AES_MIC       0x40
+#define AES_CTR       0x20
+#define AES_MICNOAUX  0x08
+
+#define AESkey ((u1_t*)AESKEY)
+#define AESaux ((u1_t*)AESAUX)
+
+extern u4_t AESAUX[];
+extern u4_t AESKEY[];
+
+u4_t os_aes(u1_t mode, xref2u1_t buf, u2_t len);
+
+#endif /* SIMPLE_LORAWAN_HOST_OSLMIC_H_ */
@@ -0,0 +1,148 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "CallbackExecutor.h"
+#include "Node.h"
+#include <string.h>
+
+namespace SimpleLoRaWAN
+{
+
+CallbackExecutor::CallbackExecutor(Node* _node, osPriority priority, uint32_t stackSize) : available(0)
+{
+    node = _node;
+    head = 0;
+    count = 0;
+    coalesced = 0;
+    dropped = 0;
+    executorThread = new Thread(executorTask, this, priority, stackSize);
+}
+
+CallbackExecutor::~CallbackExecutor()
+{
+    executorThread->terminate();
+    delete executorThread;
+}
+
+void CallbackExecutor::post(ev_t event, uint8_t port, uint8_t* data, uint8_t length)
+{
+    enqueue(event, port, data, length);
+}
+
+void CallbackExecutor::postReleasedUplinks()
+{
+    enqueue(RELEASED_UPLINKS, 0, NULL, 0);
+}
+
+// Events without a downlink leave the last SIMPLE_LORAWAN_CALLBACK_DOWNLINK_SLOTS
+// free for downlinks. An event that gets no entry is folded into the last one and
+// delivered right after it, so nothing is ever delivered ahead of an event posted
+// before it. Only when the whole queue is full a downlink is dropped.
+void CallbackExecutor::enqueue(uint8_t event, uint8_t port, uint8_t* data, uint8_t length)
+{
+    mutex.lock();
+    int limit = SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE;
+    if(length == 0){
+        limit -= SIMPLE_LORAWAN_CALLBACK_DOWNLINK_SLOTS;
+    }
+    if(count < limit){
+        Entry* entry = &entries[(head + count) % SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE];
+        count++;
+        entry->merged = 0;
+        entry->event = event;
+        entry->port = port;
+        entry->length = length;
+        if(length > 0){
+            memcpy(entry->data, data, length);
+        }
+    } else {
+        Entry* last = &entries[(head + count - 1) % SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE];
+        last->merged |= (uint32_t)1 << event;
+        coalesced++;
+        if(length > 0){
+            dropped++;
+        }
+    }
+    mutex.unlock();
+    available.release();
+}
+
+uint32_t CallbackExecutor::getCoalescedCount()
+{
+    return coalesced;
+}
+
+uint32_t CallbackExecutor::getDroppedCount()
+{
+    return dropped;
+}
+
+bool CallbackExecutor::take(Entry& entry)
+{
+    bool taken = false;
+    mutex.lock();
+    if(count > 0){
+        entry = entries[head];
+        head = (head + 1) % SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE;
+        count--;
+        taken = true;
+    }
+    mutex.unlock();
+    return taken;
+}
+
+void CallbackExecutor::deliver(uint8_t event, uint8_t port, uint8_t* data, uint8_t length)
+{
+    if(event == RELEASED_UPLINKS){
+        node->deliverReleasedUplinks();
+    } else {
+        node->dispatchEvent((ev_t)event, port, data, length);
+    }
+}
+
+// Events merged into an entry follow it, once each and lowest event number first
+void CallbackExecutor::run()
+{
+    Entry entry;
+    while(true)
+    {
+        available.wait();
+        while(take(entry)){
+            deliver(entry.event, entry.port, entry.data, entry.length);
+            for(int event = 0; event < 32; event++){
+                if(entry.merged & ((uint32_t)1 << event)){
+                    deliver(event, 0, NULL, 0);
+                }
+            }
+        }
+    }
+}
+
+void CallbackExecutor::executorTask(void const *argument)
+{
+    CallbackExecutor* self = (CallbackExecutor*)argument;
+    self->run();
+}
+
+} /* namespace SimpleLoRaWAN */
@@ -0,0 +1,100 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIMPLE_LORAWAN_CALLBACK_EXECUTOR_H_
+#define SIMPLE_LORAWAN_CALLBACK_EXECUTOR_H_
+
+#include "lmic.h"
+#include "stdint.h"
+#include "rtos.h"
+
+#ifndef SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE
+#define SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE 8
+#endif
+
+#ifndef SIMPLE_LORAWAN_CALLBACK_DOWNLINK_SLOTS
+#define SIMPLE_LORAWAN_CALLBACK_DOWNLINK_SLOTS 2
+#endif
+
+#if SIMPLE_LORAWAN_CALLBACK_DOWNLINK_SLOTS >= SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE
+#error "SIMPLE_LORAWAN_CALLBACK_DOWNLINK_SLOTS must be smaller than SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE"
+#endif
+
+namespace SimpleLoRaWAN
+{
+
+class Node;
+
+// Runs the user event, receive and released uplink handlers of a node on a worker
+// thread, so a slow handler can not delay the LMIC process thread. Posting never blocks:
+// when the queue is full, events are merged into its last entry, one delivery
+// per event type after everything posted before them. A few entries are kept
+// for downlinks, which are only dropped and counted when those are used up too.
+class CallbackExecutor
+{
+public:
+    CallbackExecutor(Node* node, osPriority priority = osPriorityNormal, uint32_t stackSize = DEFAULT_STACK_SIZE);
+    virtual ~CallbackExecutor();
+
+    void post(ev_t event, uint8_t port = 0, uint8_t* data = NULL, uint8_t length = 0);
+    void postReleasedUplinks();
+
+    uint32_t getCoalescedCount();
+    uint32_t getDroppedCount();
+
+private:
+    // posted like an event, the node hands out the expired and dropped uplinks it kept aside
+    static const uint8_t RELEASED_UPLINKS = 31;
+
+    // an EV_TXCOMPLETE carries the downlink received with it, if any
+    struct Entry
+    {
+        uint32_t merged;        // events folded in after this one while the queue was full, 0 if none
+        uint8_t event;
+        uint8_t port;
+        uint8_t length;
+        uint8_t data[MAX_LEN_FRAME];
+    };
+
+    void enqueue(uint8_t event, uint8_t port, uint8_t* data, uint8_t length);
+    bool take(Entry& entry);
+    void deliver(uint8_t event, uint8_t port, uint8_t* data, uint8_t length);
+    void run();
+    static void executorTask(void const *argument);
+
+    Node* node;
+
+    Entry entries[SIMPLE_LORAWAN_CALLBACK_QUEUE_SIZE];
+    int head;
+    int count;
+    uint32_t coalesced;
+    uint32_t dropped;
+
+    Mutex mutex;
+    Semaphore available;
+    Thread* executorThread;
+};
+
+} /* namespace SimpleLoRaWAN */
+
+#endif /* SIMPLE_LORAWAN_CALLBACK_EXECUTOR_H_ */
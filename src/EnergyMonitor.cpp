@@ -0,0 +1,186 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "EnergyMonitor.h"
+
+namespace SimpleLoRaWAN
+{
+
+const CurrentProfile EnergyMonitor::DEFAULT_PROFILE = {
+    19000,      // txBase
+    1200,       // txPerDbm, ~36 mA at 14 dBm
+    12000,      // rx
+    3000,       // idle
+    5           // sleep
+};
+
+EnergyMonitor::EnergyMonitor()
+{
+    profile = DEFAULT_PROFILE;
+    reset();
+}
+
+EnergyMonitor::EnergyMonitor(const CurrentProfile& _profile)
+{
+    profile = _profile;
+    reset();
+}
+
+void EnergyMonitor::setProfile(const CurrentProfile& _profile)
+{
+    profile = _profile;
+}
+
+const CurrentProfile& EnergyMonitor::getProfile() const
+{
+    return profile;
+}
+
+uint32_t EnergyMonitor::symbolTime(uint8_t spreadfactor, uint16_t bandwidth)
+{
+    return ((uint32_t)1 << spreadfactor) * 1000 / bandwidth;
+}
+
+// LoRa time on air (Semtech AN1200.13), explicit header, coding rate 4/5.
+// Uplinks carry a payload CRC, downlinks do not.
+uint32_t EnergyMonitor::airtime(uint8_t spreadfactor, uint16_t bandwidth, uint8_t frameLength, bool uplink)
+{
+    int lowDataRateOptimize = (spreadfactor >= 11 && bandwidth == 125) ? 1 : 0;
+    int numerator = 8 * frameLength - 4 * spreadfactor + 28 + (uplink ? 16 : 0);
+    int denominator = 4 * (spreadfactor - 2 * lowDataRateOptimize);
+    int payloadSymbols = 8;
+    if(numerator > 0) {
+        payloadSymbols += (numerator + denominator - 1) / denominator * 5;
+    }
+
+    // preamble of 8 + 4.25 symbols, counted in quarter symbols
+    uint32_t quarterSymbols = (8 * 4 + 17) + payloadSymbols * 4;
+    return quarterSymbols * symbolTime(spreadfactor, bandwidth) / 4;
+}
+
+void EnergyMonitor::transmit(uint8_t spreadfactor, uint16_t bandwidth, int8_t power, uint8_t frameLength)
+{
+    uint32_t current = profile.txBase + (power > 0 ? power * profile.txPerDbm : 0);
+    account(TRANSMIT, current, airtime(spreadfactor, bandwidth, frameLength, true));
+}
+
+void EnergyMonitor::receive(uint8_t spreadfactor, uint16_t bandwidth, uint8_t frameLength)
+{
+    account(RECEIVE, profile.rx, airtime(spreadfactor, bandwidth, frameLength, false));
+}
+
+void EnergyMonitor::receiveWindow(uint8_t spreadfactor, uint16_t bandwidth)
+{
+    account(RECEIVE, profile.rx, RX_WINDOW_SYMBOLS * symbolTime(spreadfactor, bandwidth));
+}
+
+void EnergyMonitor::idle(uint64_t duration)
+{
+    account(IDLE, profile.idle, duration);
+}
+
+void EnergyMonitor::sleep(uint64_t duration)
+{
+    account(SLEEP, profile.sleep, duration);
+}
+
+void EnergyMonitor::beginUplink()
+{
+    uplinkStart = getTotalCharge();
+    inUplink = true;
+}
+
+void EnergyMonitor::endUplink()
+{
+    if(!inUplink) {
+        return;
+    }
+    lastUplinkCharge = getTotalCharge() - uplinkStart;
+    uplinkChargeSum += lastUplinkCharge;
+    uplinkCount++;
+    inUplink = false;
+}
+
+uint64_t EnergyMonitor::getCharge(Operation operation) const
+{
+    return charge[operation];
+}
+
+uint64_t EnergyMonitor::getTime(Operation operation) const
+{
+    return time[operation];
+}
+
+uint64_t EnergyMonitor::getTotalCharge() const
+{
+    uint64_t total = 0;
+    for(int i = 0; i < OPERATIONS; i++) {
+        total += charge[i];
+    }
+    return total;
+}
+
+uint64_t EnergyMonitor::getLastUplinkCharge() const
+{
+    return lastUplinkCharge;
+}
+
+uint32_t EnergyMonitor::getUplinkCount() const
+{
+    return uplinkCount;
+}
+
+// Battery life in hours for a capacity in mAh and one uplink every interval seconds,
+// sleeping in between. Based on the average charge of the uplinks seen so far.
+uint32_t EnergyMonitor::projectedLifetime(uint32_t capacity, uint32_t interval) const
+{
+    if(uplinkCount == 0 || interval == 0) {
+        return 0;
+    }
+    uint64_t perInterval = uplinkChargeSum / uplinkCount
+                         + (uint64_t)profile.sleep * interval * 1000000;
+    uint64_t available = (uint64_t)capacity * 1000 * 3600 * 1000000;
+    return (uint32_t)(available / perInterval * interval / 3600);
+}
+
+void EnergyMonitor::reset()
+{
+    for(int i = 0; i < OPERATIONS; i++) {
+        charge[i] = 0;
+        time[i] = 0;
+    }
+    uplinkStart = 0;
+    lastUplinkCharge = 0;
+    uplinkChargeSum = 0;
+    uplinkCount = 0;
+    inUplink = false;
+}
+
+void EnergyMonitor::account(Operation operation, uint32_t current, uint64_t duration)
+{
+    charge[operation] += (uint64_t)current * duration;
+    time[operation] += duration;
+}
+
+} /* namespace SimpleLoRaWAN */
@@ -0,0 +1,104 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIMPLE_LORAWAN_ENERGY_MONITOR_H_
+#define SIMPLE_LORAWAN_ENERGY_MONITOR_H_
+
+#include "stdint.h"
+
+// Plain C++ without mbed or LMIC dependencies, so it can also be driven
+// from a host simulation.
+
+namespace SimpleLoRaWAN
+{
+
+// Supply currents in microampere, defaults are SX1276 (RFO) + Cortex-M0 figures
+struct CurrentProfile
+{
+    uint32_t txBase;            // transmit current at 0 dBm
+    uint32_t txPerDbm;          // additional transmit current per dBm
+    uint32_t rx;
+    uint32_t idle;
+    uint32_t sleep;
+};
+
+class EnergyMonitor
+{
+public:
+    enum Operation {
+        TRANSMIT = 0,
+        RECEIVE,
+        IDLE,
+        SLEEP,
+        OPERATIONS
+    };
+
+    EnergyMonitor();
+    EnergyMonitor(const CurrentProfile& profile);
+
+    void setProfile(const CurrentProfile& profile);
+    const CurrentProfile& getProfile() const;
+
+    static uint32_t airtime(uint8_t spreadfactor, uint16_t bandwidth, uint8_t frameLength, bool uplink = true);
+    static uint32_t symbolTime(uint8_t spreadfactor, uint16_t bandwidth);
+
+    void transmit(uint8_t spreadfactor, uint16_t bandwidth, int8_t power, uint8_t frameLength);
+    void receive(uint8_t spreadfactor, uint16_t bandwidth, uint8_t frameLength);
+    void receiveWindow(uint8_t spreadfactor, uint16_t bandwidth);
+    void idle(uint64_t duration);
+    void sleep(uint64_t duration);
+
+    void beginUplink();
+    void endUplink();
+
+    uint64_t getCharge(Operation operation) const;
+    uint64_t getTime(Operation operation) const;
+    uint64_t getTotalCharge() const;
+    uint64_t getLastUplinkCharge() const;
+    uint32_t getUplinkCount() const;
+
+    uint32_t projectedLifetime(uint32_t capacity, uint32_t interval) const;
+
+    void reset();
+
+    static const CurrentProfile DEFAULT_PROFILE;
+    static const uint8_t RX_WINDOW_SYMBOLS = 8;
+
+private:
+    void account(Operation operation, uint32_t current, uint64_t duration);
+
+    CurrentProfile profile;
+
+    uint64_t charge[OPERATIONS];    // picocoulomb (uA * us)
+    uint64_t time[OPERATIONS];      // microseconds
+
+    uint64_t uplinkStart;
+    uint64_t lastUplinkCharge;
+    uint64_t uplinkChargeSum;
+    uint32_t uplinkCount;
+    bool inUplink;
+};
+
+} /* namespace SimpleLoRaWAN */
+
+#endif /* SIMPLE_LORAWAN_ENERGY_MONITOR_H_ */
@@ -0,0 +1,211 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "LinkSupervisor.h"
+
+namespace SimpleLoRaWAN
+{
+
+LinkSupervisor::LinkSupervisor()
+{
+    marginThreshold = 5;
+    retriesPerStep = 4;
+    probeInterval = 15 * 60 * 1000;
+    historyHead = 0;
+    historyCount = 0;
+    reset();
+}
+
+// Back to an unknown link, the settings and the history are kept
+void LinkSupervisor::reset()
+{
+    state = LINK_UNKNOWN;
+    step = NO_ACTION;
+    margin = 0;
+    gateways = 0;
+    unanswered = 0;
+    lastProbe = 0;
+}
+
+void LinkSupervisor::setMarginThreshold(uint8_t _margin)
+{
+    marginThreshold = _margin;
+}
+
+void LinkSupervisor::setRetriesPerStep(uint8_t retries)
+{
+    retriesPerStep = retries;
+}
+
+void LinkSupervisor::setProbeInterval(uint32_t interval)
+{
+    probeInterval = interval;
+}
+
+LinkSupervisor::Action LinkSupervisor::onLinkCheckAnswer(uint8_t _margin, uint8_t _gateways, uint32_t now)
+{
+    margin = _margin;
+    gateways = _gateways;
+    return alive(margin < marginThreshold ? LINK_WEAK : LINK_GOOD, now);
+}
+
+// Any downlink proves the link, only a link check answer tells whether it is weak
+LinkSupervisor::Action LinkSupervisor::onLinkAlive(uint32_t now)
+{
+    return alive(state == LINK_WEAK ? LINK_WEAK : LINK_GOOD, now);
+}
+
+LinkSupervisor::Action LinkSupervisor::onLinkDead(uint32_t now)
+{
+    if(state == LINK_RECOVERING || state == LINK_DEAD) {
+        return NO_ACTION;
+    }
+    setState(LINK_RECOVERING, now);
+    step = RAISE_SPREADFACTOR;
+    unanswered = 0;
+    return step;
+}
+
+// While recovering, every step gets a number of uplinks to get an answer
+// before it is repeated. Steps that can not be repeated are reported failed.
+LinkSupervisor::Action LinkSupervisor::onUnansweredUplink(uint32_t now)
+{
+    if(state != LINK_RECOVERING) {
+        return NO_ACTION;
+    }
+    if(++unanswered < retriesPerStep) {
+        return NO_ACTION;
+    }
+    unanswered = 0;
+    return step == REJOIN ? onStepFailed(now) : step;
+}
+
+LinkSupervisor::Action LinkSupervisor::onStepFailed(uint32_t now)
+{
+    if(state != LINK_RECOVERING) {
+        return NO_ACTION;
+    }
+    unanswered = 0;
+    switch(step) {
+        case RAISE_SPREADFACTOR:
+            step = RAISE_TX_POWER;
+            break;
+        case RAISE_TX_POWER:
+            step = REJOIN;
+            break;
+        default:
+            step = NO_ACTION;
+            lastProbe = now;
+            setState(LINK_DEAD, now);
+            return PAUSE_UPLINKS;
+    }
+    return step;
+}
+
+bool LinkSupervisor::allowsUplink(uint32_t now)
+{
+    if(state != LINK_DEAD) {
+        return true;
+    }
+    if(now - lastProbe >= probeInterval) {
+        lastProbe = now;
+        return true;
+    }
+    return false;
+}
+
+LinkSupervisor::State LinkSupervisor::getState() const
+{
+    return state;
+}
+
+uint8_t LinkSupervisor::getMargin() const
+{
+    return margin;
+}
+
+uint8_t LinkSupervisor::getGatewayCount() const
+{
+    return gateways;
+}
+
+int LinkSupervisor::getTransitionCount() const
+{
+    return historyCount;
+}
+
+LinkSupervisor::Transition LinkSupervisor::getTransition(int index) const
+{
+    if(index < 0 || index >= historyCount) {
+        Transition none = { LINK_UNKNOWN, LINK_UNKNOWN, 0 };
+        return none;
+    }
+    int position = historyHead - 1 - index;
+    if(position < 0) {
+        position += SIMPLE_LORAWAN_LINK_HISTORY_SIZE;
+    }
+    return history[position];
+}
+
+const char* LinkSupervisor::stateName(State state)
+{
+    switch(state) {
+        case LINK_GOOD:
+            return "good";
+        case LINK_WEAK:
+            return "weak";
+        case LINK_RECOVERING:
+            return "recovering";
+        case LINK_DEAD:
+            return "dead";
+        default:
+            return "unknown";
+    }
+}
+
+LinkSupervisor::Action LinkSupervisor::alive(State _state, uint32_t now)
+{
+    bool wasDead = (state == LINK_DEAD);
+    step = NO_ACTION;
+    unanswered = 0;
+    setState(_state, now);
+    return wasDead ? RESUME_UPLINKS : NO_ACTION;
+}
+
+void LinkSupervisor::setState(State _state, uint32_t now)
+{
+    if(state == _state) {
+        return;
+    }
+    history[historyHead].from = state;
+    history[historyHead].to = _state;
+    history[historyHead].time = now;
+    historyHead = (historyHead + 1) % SIMPLE_LORAWAN_LINK_HISTORY_SIZE;
+    if(historyCount < SIMPLE_LORAWAN_LINK_HISTORY_SIZE) {
+        historyCount++;
+    }
+    state = _state;
+}
+
+} /* namespace SimpleLoRaWAN */
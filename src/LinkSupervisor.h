@@ -0,0 +1,115 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIMPLE_LORAWAN_LINK_SUPERVISOR_H_
+#define SIMPLE_LORAWAN_LINK_SUPERVISOR_H_
+
+#include "stdint.h"
+
+#ifndef SIMPLE_LORAWAN_LINK_HISTORY_SIZE
+#define SIMPLE_LORAWAN_LINK_HISTORY_SIZE 16
+#endif
+
+namespace SimpleLoRaWAN
+{
+
+// Tracks the link quality and decides on recovery steps when the link is lost:
+// raise the spreading factor, then the transmit power, then rejoin. When all
+// steps are exhausted the link is dead and uplinks are paused, except for a
+// probe every probe interval. Times are in milliseconds.
+class LinkSupervisor
+{
+public:
+    enum State {
+        LINK_UNKNOWN = 0,
+        LINK_GOOD,
+        LINK_WEAK,
+        LINK_RECOVERING,
+        LINK_DEAD
+    };
+
+    enum Action {
+        NO_ACTION = 0,
+        RAISE_SPREADFACTOR,
+        RAISE_TX_POWER,
+        REJOIN,
+        PAUSE_UPLINKS,
+        RESUME_UPLINKS
+    };
+
+    struct Transition
+    {
+        State from;
+        State to;
+        uint32_t time;
+    };
+
+    LinkSupervisor();
+
+    void setMarginThreshold(uint8_t margin);
+    void setRetriesPerStep(uint8_t retries);
+    void setProbeInterval(uint32_t interval);
+
+    Action onLinkCheckAnswer(uint8_t margin, uint8_t gateways, uint32_t now);
+    Action onLinkAlive(uint32_t now);
+    Action onLinkDead(uint32_t now);
+    Action onUnansweredUplink(uint32_t now);
+    Action onStepFailed(uint32_t now);
+
+    bool allowsUplink(uint32_t now);
+    void reset();
+
+    State getState() const;
+    uint8_t getMargin() const;
+    uint8_t getGatewayCount() const;
+
+    int getTransitionCount() const;
+    // 0 is the most recent, an index outside 0 to getTransitionCount() - 1 gives
+    // LINK_UNKNOWN to LINK_UNKNOWN at time 0
+    Transition getTransition(int index) const;
+
+    static const char* stateName(State state);
+
+private:
+    Action alive(State state, uint32_t now);
+    void setState(State state, uint32_t now);
+
+    State state;
+    Action step;
+    uint8_t margin;
+    uint8_t gateways;
+
+    uint8_t marginThreshold;
+    uint8_t retriesPerStep;
+    uint8_t unanswered;
+    uint32_t probeInterval;
+    uint32_t lastProbe;
+
+    Transition history[SIMPLE_LORAWAN_LINK_HISTORY_SIZE];
+    int historyHead;
+    int historyCount;
+};
+
+} /* namespace SimpleLoRaWAN */
+
+#endif /* SIMPLE_LORAWAN_LINK_SUPERVISOR_H_ */
@@ -76,6 +76,31 @@ Node::Node()
     linkDeadEventHandler = NULL;
     linkAliveEventHandler = NULL;
     receiveHandler = NULL;
+    uplinkExpiredHandler = NULL;
+    uplinkDroppedHandler = NULL;
+
+    energyMonitor = NULL;
+    energyTimestamp = 0;
+    radioBusy = false;
+    radioJoining = false;
+    radioDatarate = 0;
+    radioTime = 0;
+
+    clockTicks = 0;
+    clockTimestamp = os_getTime();
+
+    linkSupervision = false;
+    linkCheckMode = -1;
+    recovering = false;
+    rejoinPending = false;
+    rejoining = false;
+    savedDatarate = 0;
+    savedTxPower = 0;
+    frameDatarate = false;
+    frameOverride = 0;
+    framePrevious = 0;
+
+    executor = NULL;
 
     log->debug("Creating Simple-LoRaWAN node");
 
@@ -98,30 +123,360 @@ void Node::init()
 }
 
 
-void Node::send(char* data, int size, bool acknowledge)
+bool Node::send(char* data, int size, bool acknowledge)
 {
-    send(1, (uint8_t*) data, size, acknowledge);
+    return send(1, (uint8_t*) data, size, acknowledge);
 }
 
-void Node::send(unsigned char port, char* data, int size, bool acknowledge)
+bool Node::send(unsigned char port, char* data, int size, bool acknowledge)
 {
-    send(port, (uint8_t*) data, size, acknowledge);
+    return send(port, (uint8_t*) data, size, acknowledge);
 }
 
-void Node::send(uint8_t* data, int size, bool acknowledge)
+bool Node::send(uint8_t* data, int size, bool acknowledge)
 {
-    send(1, data, size, acknowledge);
+    return send(1, data, size, acknowledge);
 }
 
-void Node::send(unsigned char port, uint8_t* data, int size, bool acknowledge)
+bool Node::send(unsigned char port, uint8_t* data, int size, bool acknowledge)
 {
     log->debug("Sending data with length %d, on port %d and acknowledge is %d", size, port, acknowledge);
+    if(!fitsDataRate(size)){
+        log->info("Payload of %d bytes too large for DR%d, not sent", size, LMIC.datarate);
+        return false;
+    }
+    if(energyMonitor != NULL){
+        energyMutex.lock();
+        if(!radioBusy){
+            accountIdle();
+        }
+        energyMonitor->beginUplink();
+        energyMutex.unlock();
+    }
     memcpy (LMIC.frame, data, size);
     LMIC_setTxData2(port, LMIC.frame, size, acknowledge);
+    return true;
+}
+
+bool Node::sendAtDataRate(uint8_t datarate, unsigned char port, uint8_t* data, int size, bool acknowledge)
+{
+    if(recovering && LMIC.datarate < datarate){
+        log->debug("Link recovery active, sending at DR%d instead of DR%d", LMIC.datarate, datarate);
+        datarate = LMIC.datarate;
+    }
+    if(!frameDatarate){
+        framePrevious = LMIC.datarate;
+    }
+    frameDatarate = true;
+    frameOverride = datarate;
+    LMIC_setDrTxpow(datarate, LMIC.adrTxPow);
+
+    if(!send(port, data, size, acknowledge)){
+        restoreFrameDatarate();
+        return false;
+    }
+    return true;
+}
+
+// A data rate the network set with a LinkADRReq in the meantime is kept
+void Node::restoreFrameDatarate()
+{
+    if(!frameDatarate){
+        return;
+    }
+    frameDatarate = false;
+    if(LMIC.datarate == frameOverride && framePrevious != frameOverride){
+        log->debug("Restoring DR%d after the uplink at DR%d", framePrevious, frameOverride);
+        LMIC_setDrTxpow(framePrevious, LMIC.adrTxPow);
+    }
+}
+
+// The data rate can be lowered at run time by ADR or link recovery
+int Node::maxPayload()
+{
+    typedef Region::Active R;
+    int limit = MAX_LEN_FRAME - Region::FRAME_OVERHEAD;
+    if(LMIC.datarate < R::dataRates && R::maxPayload(LMIC.datarate) < limit){
+        limit = R::maxPayload(LMIC.datarate);
+    }
+    return limit;
+}
+
+bool Node::fitsDataRate(int size)
+{
+    return size >= 0 && size <= maxPayload();
+}
+
+bool Node::queue(unsigned char port, uint8_t* data, int size, uint8_t priority,
+                 uint32_t lifetime, uint16_t key, bool acknowledge)
+{
+    log->debug("Queueing data with length %d, on port %d with priority %d", size, port, priority);
+    uplinkMutex.lock();
+    bool queued = uplinkScheduler.push(port, data, size, milliseconds(), priority, lifetime, key, acknowledge);
+    uplinkMutex.unlock();
+    releaseUplinks();
+    if(!queued){
+        log->info("Uplink queue full, data not queued");
+    }
+    return queued;
+}
+
+int Node::queuedUplinks()
+{
+    uplinkMutex.lock();
+    int size = uplinkScheduler.size();
+    uplinkMutex.unlock();
+    return size;
 }
 
+void Node::clearUplinkQueue()
+{
+    uplinkMutex.lock();
+    uplinkScheduler.clear();
+    uplinkMutex.unlock();
+}
+
+// The uplink is picked at the moment it can go out, so it is the most urgent one at that time
+void Node::sendQueued()
+{
+    uint32_t now = milliseconds();
+    if(!canSend() || queuedUplinks() == 0){
+        return;
+    }
+
+    if(linkSupervision && !linkSupervisor.allowsUplink(now)){
+        return;
+    }
+
+    Uplink uplink;
+    uplinkMutex.lock();
+    // only uplinks that fit the current data rate are taken, larger ones wait
+    bool available = uplinkScheduler.pop(uplink, now, maxPayload());
+    uplinkMutex.unlock();
+    releaseUplinks();
+
+    if(available){
+        send(uplink.port, uplink.data, uplink.size, uplink.acknowledge);
+    }
+}
+
+// The handlers run without uplinkMutex held, so they are free to queue new uplinks
+// With deferred callbacks the expired and dropped handlers run on the executor thread too
+void Node::releaseUplinks()
+{
+    if(executor != NULL){
+        uplinkMutex.lock();
+        bool released = uplinkScheduler.hasReleased();
+        uplinkMutex.unlock();
+        if(released){
+            executor->postReleasedUplinks();
+        }
+        return;
+    }
+    deliverReleasedUplinks();
+}
+
+void Node::deliverReleasedUplinks()
+{
+    Uplink uplink;
+    UplinkScheduler::Release reason;
+    while(true){
+        uplinkMutex.lock();
+        bool released = uplinkScheduler.takeReleased(uplink, reason);
+        uplinkMutex.unlock();
+        if(!released){
+            return;
+        }
+
+        if(reason == UplinkScheduler::EXPIRED){
+            log->debug("Queued uplink on port %d expired", uplink.port);
+            if(uplinkExpiredHandler != NULL){
+                uplinkExpiredHandler(uplink);
+            }
+        } else {
+            log->debug("Queued uplink on port %d dropped", uplink.port);
+            if(uplinkDroppedHandler != NULL){
+                uplinkDroppedHandler(uplink);
+            }
+        }
+    }
+}
+
+// os_getTime() is a signed tick count that jumps from positive to negative after
+// about 38 hours. The tick deltas are accumulated into a millisecond clock that
+// wraps cleanly at 2^32 ms, for the deadlines of the uplink queue and link supervisor.
+// It has to be sampled at least once every 2^31 ticks, which the process thread does.
+uint32_t Node::milliseconds()
+{
+    clockMutex.lock();
+    ostime_t now = os_getTime();
+    clockTicks += (uint32_t)(now - clockTimestamp);
+    clockTimestamp = now;
+    uint32_t ms = (uint32_t)(clockTicks * 1000 / OSTICKS_PER_SEC);
+    clockMutex.unlock();
+    return ms;
+}
+
+bool Node::canSend()
+{
+    if(LMIC.devaddr == 0 || (LMIC.opmode & (OP_JOINING | OP_TXDATA | OP_TXRXPEND))){
+        return false;
+    }
+    ostime_t now = os_getTime();
+    if((s4_t)(now - LMIC.globalDutyAvail) < 0){
+        return false;
+    }
+#if defined(CFG_eu868)
+    // LMIC holds a frame under OP_TXDATA until a band with an enabled channel for the
+    // current data rate is free, a more urgent uplink queued meanwhile can not overtake it
+    bool usable = false;
+    for(u1_t band = 0; band < MAX_BANDS; band++){
+        if(!bandUsable(band)){
+            continue;
+        }
+        if((s4_t)(now - LMIC.bands[band].avail) >= 0){
+            return true;
+        }
+        usable = true;
+    }
+    // without any usable band LMIC sends right away
+    return !usable;
+#else
+    return true;
+#endif
+}
+
+#if defined(CFG_eu868)
+bool Node::bandUsable(u1_t band)
+{
+    for(u1_t channel = 0; channel < MAX_CHANNELS; channel++){
+        if((LMIC.channelMap & (1 << channel)) != 0
+           && (LMIC.channelDrMap[channel] & (1 << (LMIC.datarate & 0xF))) != 0
+           && (LMIC.channelFreq[channel] & 0x3) == band){
+            return true;
+        }
+    }
+    return false;
+}
+#endif
 
 void Node::onEvent(ev_t event)
+{
+    uint8_t buffer[MAX_LEN_FRAME];
+    uint8_t port = 0;
+    uint8_t length = 0;
+
+    switch(event) {
+        case EV_SCAN_TIMEOUT:
+            log->info("Scan timeout event");
+            break;
+        case EV_BEACON_FOUND:
+            log->info("Beacon found event");
+            break;
+        case EV_BEACON_MISSED:
+            log->info("Beacon missed event");
+            break;
+        case EV_BEACON_TRACKED:
+            log->info("Beacon tracked event");
+            break;
+        case EV_JOINING:
+            log->info("Joining event");
+            break;
+        case EV_JOINED:
+            log->info("Joined event");
+            if(rejoining){
+                restoreLinkSettings();
+            }
+            if(linkSupervision){
+                superviseLink(linkSupervisor.onLinkAlive(milliseconds()));
+            }
+            break;
+        case EV_RFU1:
+            log->info("RFU1 event");
+            break;
+        case EV_JOIN_FAILED:
+            log->info("Join failed event");
+            if(linkSupervision){
+                superviseLink(linkSupervisor.onStepFailed(milliseconds()));
+            }
+            break;
+        case EV_REJOIN_FAILED:
+            log->info("Rejoin failed event");
+            if(linkSupervision){
+                superviseLink(linkSupervisor.onStepFailed(milliseconds()));
+            }
+            break;
+        case EV_TXCOMPLETE:
+            log->info("Transmit complete event");
+            if(energyMonitor != NULL){
+                energyMutex.lock();
+                accountRadio(true);
+                energyMonitor->endUplink();
+                log->debug("Uplink charge: %d uC", (int)(energyMonitor->getLastUplinkCharge() / 1000000));
+                energyMutex.unlock();
+            }
+            restoreFrameDatarate();
+            if(linkSupervision){
+                if(LMIC.txrxFlags & (TXRX_DNW1 | TXRX_DNW2)){
+                    readLinkCheckAnswer();
+                } else {
+                    superviseLink(linkSupervisor.onUnansweredUplink(milliseconds()));
+                }
+            }
+            if (LMIC.txrxFlags & TXRX_ACK){             // needs ACK and gets ACK
+              log->debug("need ACK and got ACK");
+            } else if(LMIC.txrxFlags & TXRX_NACK) {     // needs ACK and gets NO ACK
+              log->debug("need ACK and got NO ACK");
+            } else {                                    // needs no ACK
+              log->debug("NO ACK needed");
+            }
+
+            if (LMIC.dataLen) {
+              memcpy (buffer, LMIC.frame + LMIC.dataBeg, LMIC.dataLen);
+              port = (LMIC.txrxFlags & TXRX_PORT) ? LMIC.frame[LMIC.dataBeg-1] : 0;
+              length = LMIC.dataLen;
+              log->info("Data payload received");
+              log->debug("Received %d bytes of payload on port %d", LMIC.dataLen, port);
+            } else {
+              log->debug("No data received");
+            }
+            break;
+        case EV_LOST_TSYNC:
+            log->info("Lost tsync event");
+            break;
+        case EV_RESET:
+            log->info("Reset event");
+            break;
+        case EV_RXCOMPLETE:
+            log->info("Receive complete event");
+            break;
+        case EV_LINK_DEAD:
+            log->info("Link dead event");
+            if(linkSupervision){
+                superviseLink(linkSupervisor.onLinkDead(milliseconds()));
+            }
+            break;
+        case EV_LINK_ALIVE:
+            log->info("Link alive event");
+            if(linkSupervision){
+                superviseLink(linkSupervisor.onLinkAlive(milliseconds()));
+            }
+            break;
+         default:
+            // Unknown event
+            break;
+    }
+
+    if(executor != NULL){
+        executor->post(event, port, buffer, length);
+    } else {
+        dispatchEvent(event, port, buffer, length);
+    }
+}
+
+// Same order as before the handlers could be deferred: the generic event
+// handler, then a downlink, then the handler of the specific event
+void Node::dispatchEvent(ev_t event, uint8_t port, uint8_t* data, uint8_t length)
 {
     if(eventHandler != NULL){
         log->info("Event: %d", event);
@@ -130,110 +485,79 @@ void Node::onEvent(ev_t event)
 
     switch(event) {
         case EV_SCAN_TIMEOUT:
-            log->info("Scan timeout event");
             if(scanTimeoutEventHandler != NULL){
                 scanTimeoutEventHandler();
             }
             break;
         case EV_BEACON_FOUND:
-            log->info("Beacon found event");
             if(beaconFoundEventHandler != NULL){
                 beaconFoundEventHandler();
             }
             break;
         case EV_BEACON_MISSED:
-            log->info("Beacon missed event");
             if(beaconMissedEventHandler != NULL){
                 beaconMissedEventHandler();
             }
             break;
         case EV_BEACON_TRACKED:
-            log->info("Beacon tracked event");
             if(beaconTrackedEventHandler != NULL){
                 beaconTrackedEventHandler();
             }
             break;
         case EV_JOINING:
-            log->info("Joining event");
             if(joiningEventHandler != NULL){
                 joiningEventHandler();
             }
             break;
         case EV_JOINED:
-            log->info("Joined event");
             if(joinedEventHandler != NULL){
                 joinedEventHandler();
             }
             break;
         case EV_RFU1:
-            log->info("RFU1 event");
             if(rfu1EventHandler != NULL){
                 rfu1EventHandler();
             }
             break;
         case EV_JOIN_FAILED:
-            log->info("Join failed event");
             if(joinFailedEventHandler != NULL){
                 joinFailedEventHandler();
             }
             break;
         case EV_REJOIN_FAILED:
-            log->info("Rejoin failed event");
             if(rejoinFailedEventHandler != NULL){
                 rejoinFailedEventHandler();
             }
             break;
         case EV_TXCOMPLETE:
-            log->info("Transmit complete event");
-            if (LMIC.txrxFlags & TXRX_ACK){             // needs ACK and gets ACK
-              log->debug("need ACK and got ACK");
-            } else if(LMIC.txrxFlags & TXRX_NACK) {     // needs ACK and gets NO ACK
-              log->debug("need ACK and got NO ACK");
-            } else {                                    // needs no ACK
-              log->debug("NO ACK needed");
-            }
-
-            if (LMIC.dataLen) {
-              uint8_t buffer[MAX_LEN_FRAME];
-              memcpy (buffer, LMIC.frame + LMIC.dataBeg, LMIC.dataLen);
-              uint8_t port = (LMIC.txrxFlags & TXRX_PORT) ? LMIC.frame[LMIC.dataBeg-1] : 0;
-              log->info("Data payload received");
-              log->debug("Received %d bytes of payload on port %d", LMIC.dataLen, port);
-              receiveHandler(port, buffer, LMIC.dataLen);
-            } else {
-              log->debug("No data received");
+            if(length > 0 && receiveHandler != NULL){
+                receiveHandler(port, data, length);
             }
-
             if(txCompleteEventHandler != NULL){
                 txCompleteEventHandler();
             }
             break;
         case EV_LOST_TSYNC:
-            log->info("Lost tsync event");
             if(lostTsyncEventHandler != NULL){
                 lostTsyncEventHandler();
             }
             break;
         case EV_RESET:
-            log->info("Reset event");
             if(resetEventHandler != NULL){
                 resetEventHandler();
             }
             break;
         case EV_RXCOMPLETE:
-            log->info("Receive complete event");
             if(rxCompleteEventHandler != NULL){
                 rxCompleteEventHandler();
             }
             break;
         case EV_LINK_DEAD:
-            log->info("Link dead event");
             if(linkDeadEventHandler != NULL){
                 linkDeadEventHandler();
             }
             break;
         case EV_LINK_ALIVE:
-            log->info("Link alive event");
             if(linkAliveEventHandler != NULL){
                 linkAliveEventHandler();
             }
@@ -340,6 +664,18 @@ void Node::setLinkAliveEventHandler(void (*fnc)())
     linkAliveEventHandler = fnc;
 }
 
+void Node::setUplinkExpiredHandler(void (*fnc)(const Uplink&))
+{
+    log->debug("Setting uplink expired handler");
+    uplinkExpiredHandler = fnc;
+}
+
+void Node::setUplinkDroppedHandler(void (*fnc)(const Uplink&))
+{
+    log->debug("Setting uplink dropped handler");
+    uplinkDroppedHandler = fnc;
+}
+
 void Node::setReceiveHandler(void (*fnc)(uint8_t, uint8_t*, uint8_t))
 {
    log->debug("Setting receive eventhanlder");
@@ -349,6 +685,28 @@ void Node::setReceiveHandler(void (*fnc)(uint8_t, uint8_t*, uint8_t))
 void Node::process()
 {
     os_runloop_once();
+    // LMIC must not be reset from its own event callback, so a rejoin starts here
+    if(rejoinPending){
+        rejoinPending = false;
+        rejoining = true;
+        frameDatarate = false;
+        rejoin();
+    }
+    if(energyMonitor != NULL){
+        energyMutex.lock();
+        accountRadio(false);
+        energyMutex.unlock();
+    }
+    sendQueued();
+}
+
+void Node::enableDeferredCallbacks(osPriority priority, uint32_t stackSize)
+{
+    if(executor != NULL){
+        return;
+    }
+    log->debug("Enabling deferred callbacks");
+    executor = new CallbackExecutor(this, priority, stackSize);
 }
 
 void Node::processTask(void const *argument)
@@ -374,9 +732,138 @@ void Node::disableLinkCheck()
 
 void Node::setLinkCheck(int state)
 {
+    linkCheckMode = state;
     LMIC_setLinkCheckMode(state);
 }
 
+void Node::enableLinkSupervision()
+{
+    log->debug("Enabling link supervision");
+    linkSupervisor.reset();
+    recovering = false;
+    linkSupervision = true;
+}
+
+void Node::disableLinkSupervision()
+{
+    log->debug("Disabling link supervision");
+    linkSupervision = false;
+    linkSupervisor.reset();
+}
+
+LinkSupervisor::State Node::getLinkState()
+{
+    return linkSupervisor.getState();
+}
+
+LinkSupervisor& Node::getLinkSupervisor()
+{
+    return linkSupervisor;
+}
+
+// Only OTAA nodes can rejoin
+bool Node::canRejoin()
+{
+    return false;
+}
+
+void Node::rejoin()
+{
+}
+
+// LMIC_reset() drops the data rate, transmit power and link check mode of the
+// application, so the ones in use before the link recovery started are put back
+void Node::restoreLinkSettings()
+{
+    rejoining = false;
+    if(recovering){
+        log->info("Rejoined, restoring DR%d at %d dBm", savedDatarate, savedTxPower);
+        LMIC_setDrTxpow(savedDatarate, savedTxPower);
+    }
+    if(linkCheckMode >= 0){
+        LMIC_setLinkCheckMode(linkCheckMode);
+    }
+}
+
+void Node::superviseLink(LinkSupervisor::Action action)
+{
+    while(action != LinkSupervisor::NO_ACTION && !applyLinkAction(action)){
+        action = linkSupervisor.onStepFailed(milliseconds());
+    }
+
+    LinkSupervisor::State state = linkSupervisor.getState();
+    if(state == LinkSupervisor::LINK_GOOD || state == LinkSupervisor::LINK_WEAK){
+        recovering = false;
+    }
+}
+
+bool Node::applyLinkAction(LinkSupervisor::Action action)
+{
+    bool recoveryStep = action == LinkSupervisor::RAISE_SPREADFACTOR
+                     || action == LinkSupervisor::RAISE_TX_POWER
+                     || action == LinkSupervisor::REJOIN;
+    if(recoveryStep && !recovering){
+        recovering = true;
+        savedDatarate = LMIC.datarate;
+        savedTxPower = LMIC.adrTxPow;
+    }
+
+    switch(action) {
+        case LinkSupervisor::RAISE_SPREADFACTOR:
+            if(LMIC.datarate == 0){
+                return false;
+            }
+            log->info("Link recovery: lowering data rate to DR%d", LMIC.datarate - 1);
+            LMIC_setDrTxpow(LMIC.datarate - 1, LMIC.adrTxPow);
+            return true;
+        case LinkSupervisor::RAISE_TX_POWER:
+            if(LMIC.adrTxPow >= Region::Active::maxTxPower){
+                return false;
+            }
+            log->info("Link recovery: raising transmit power to %d dBm", Region::Active::maxTxPower);
+            LMIC_setDrTxpow(LMIC.datarate, Region::Active::maxTxPower);
+            return true;
+        case LinkSupervisor::REJOIN:
+            if(!canRejoin()){
+                return false;
+            }
+            log->info("Link recovery: rejoining");
+            rejoinPending = true;
+            return true;
+        case LinkSupervisor::PAUSE_UPLINKS:
+            log->info("Link dead, pausing uplink queue");
+            return true;
+        case LinkSupervisor::RESUME_UPLINKS:
+            log->info("Link restored, resuming uplink queue");
+            return true;
+        default:
+            return true;
+    }
+}
+
+// LMIC handles the LinkCheckAns MAC command but does not keep its content
+void Node::readLinkCheckAnswer()
+{
+    static const uint8_t commandLength[] = { 0, 0, 3, 5, 2, 5, 1, 6, 2 };
+    uint32_t now = milliseconds();
+    uint8_t* options = LMIC.frame + OFF_DAT_OPTS;
+    int length = LMIC.frame[OFF_DAT_FCT] & FCT_OPTLEN;
+
+    for(int i = 0; i < length; ) {
+        uint8_t command = options[i];
+        if(command >= sizeof(commandLength) || commandLength[command] == 0 || i + commandLength[command] > length){
+            break;
+        }
+        if(command == MCMD_LCHK_ANS){
+            log->debug("Link check answer: margin %d dB, %d gateways", options[i + 1], options[i + 2]);
+            superviseLink(linkSupervisor.onLinkCheckAnswer(options[i + 1], options[i + 2], now));
+            return;
+        }
+        i += commandLength[command];
+    }
+    superviseLink(linkSupervisor.onLinkAlive(now));
+}
+
 void Node::setSpreadFactor(int spreadfactor)
 {
     LMIC_setDrTxpow(spreadfactor, 14);
@@ -388,5 +875,81 @@ int Node::timeUntilNextSend()
     return LMIC.globalDutyAvail;
 }
 
+void Node::setEnergyMonitor(EnergyMonitor* monitor)
+{
+    log->debug("Setting energy monitor");
+    energyMutex.lock();
+    energyMonitor = monitor;
+    energyTimestamp = os_getTime();
+    radioBusy = (LMIC.opmode & OP_TXRXPEND) != 0;
+    radioJoining = (LMIC.devaddr == 0);
+    radioDatarate = LMIC.datarate;
+    radioTime = 0;
+    energyMutex.unlock();
+}
+
+// osticks2us() overflows after about 35 minutes
+static uint64_t elapsedMicroseconds(ostime_t ticks)
+{
+    return (uint64_t)(uint32_t)ticks * US_PER_OSTICK;
+}
+
+// hal_sleep() does not power down yet, so time between radio operations is idle time
+void Node::accountIdle()
+{
+    ostime_t now = os_getTime();
+    energyMonitor->idle(elapsedMicroseconds(now - energyTimestamp));
+    energyTimestamp = now;
+}
+
+// LMIC reports a confirmed uplink once, after all of its retransmissions, and
+// join requests not at all, so every transmission is picked up from OP_TXRXPEND:
+// it is set when the radio starts to transmit and cleared after the receive windows.
+void Node::accountRadio(bool complete)
+{
+    typedef Region::Active R;
+    static const uint8_t JOIN_ACCEPT_LENGTH = 33;      // with CFList
+
+    bool busy = (LMIC.opmode & OP_TXRXPEND) != 0;
+    if(busy == radioBusy){
+        return;
+    }
+    radioBusy = busy;
+
+    if(busy){
+        accountIdle();
+        radioJoining = (LMIC.devaddr == 0);
+        radioDatarate = LMIC.datarate < R::dataRates ? LMIC.datarate : 0;
+        radioTime = energyMonitor->getTime(EnergyMonitor::TRANSMIT) + energyMonitor->getTime(EnergyMonitor::RECEIVE);
+        // LMIC.dataLen holds the length of the frame being transmitted
+        energyMonitor->transmit(R::spreadingFactor(radioDatarate), R::bandwidth(radioDatarate), LMIC.adrTxPow, LMIC.dataLen);
+        return;
+    }
+
+    uint8_t dr = radioDatarate;
+    uint8_t rx2 = LMIC.dn2Dr < R::dataRates ? LMIC.dn2Dr : dr;
+    if(radioJoining && LMIC.devaddr != 0){
+        energyMonitor->receive(R::spreadingFactor(dr), R::bandwidth(dr), JOIN_ACCEPT_LENGTH);
+    } else if(complete && (LMIC.txrxFlags & TXRX_DNW1)){
+        energyMonitor->receive(R::spreadingFactor(dr), R::bandwidth(dr), LMIC.dataBeg + LMIC.dataLen + 4);
+    } else {
+        energyMonitor->receiveWindow(R::spreadingFactor(dr), R::bandwidth(dr));
+        if(complete && (LMIC.txrxFlags & TXRX_DNW2)){
+            energyMonitor->receive(R::spreadingFactor(rx2), R::bandwidth(rx2), LMIC.dataBeg + LMIC.dataLen + 4);
+        } else {
+            energyMonitor->receiveWindow(R::spreadingFactor(rx2), R::bandwidth(rx2));
+        }
+    }
+
+    // the part of the attempt that was not spent on air was spent idle
+    radioTime = energyMonitor->getTime(EnergyMonitor::TRANSMIT) + energyMonitor->getTime(EnergyMonitor::RECEIVE) - radioTime;
+    ostime_t now = os_getTime();
+    uint64_t elapsed = elapsedMicroseconds(now - energyTimestamp);
+    if(elapsed > radioTime){
+        energyMonitor->idle(elapsed - radioTime);
+    }
+    energyTimestamp = now;
+}
+
 
 } /* namespace SimpleLoRaWAN */
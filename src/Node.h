@@ -30,6 +30,11 @@
 #include "stdint.h"
 #include "LogIt.h"
 #include "rtos.h"
+#include "Region.h"
+#include "EnergyMonitor.h"
+#include "UplinkScheduler.h"
+#include "LinkSupervisor.h"
+#include "CallbackExecutor.h"
 
 #ifdef RFM95_RESET_CONNECTED
 #include "mbed.h"
@@ -43,16 +48,41 @@ class Node
 public:
     Node();
     virtual ~Node();
-    void send(char* data, int size, bool acknowledge = false);
-    void send(unsigned char port, char* data, int size, bool acknowledge = false);
-    void send(uint8_t* data, int size, bool acknowledge = false);
-    void send(unsigned char port, uint8_t* data, int size, bool acknowledge = false);
+    bool send(char* data, int size, bool acknowledge = false);
+    bool send(unsigned char port, char* data, int size, bool acknowledge = false);
+    bool send(uint8_t* data, int size, bool acknowledge = false);
+    bool send(unsigned char port, uint8_t* data, int size, bool acknowledge = false);
+
+    // Payload size is checked at compile time against the region's limit for the data rate.
+    // Only this uplink is sent at that data rate, the one ADR or link recovery chose is put
+    // back when it completes. While link recovery runs a lower data rate it is kept, so the
+    // send fails when the payload does not fit it.
+    template<class R, uint8_t DR, int Size>
+    bool send(unsigned char port, uint8_t (&data)[Size], bool acknowledge = false)
+    {
+        static_assert(Size <= Region::DataRate<R, DR>::maxPayload, "payload too large for this data rate");
+        static_assert(Size + Region::FRAME_OVERHEAD <= MAX_LEN_FRAME, "payload does not fit the LMIC frame buffer");
+        return sendAtDataRate(Region::DataRate<R, DR>::index, port, data, Size, acknowledge);
+    }
+
+    // Queued uplinks are sent one at a time when LMIC is idle and the duty cycle allows it.
+    // Lifetime is in milliseconds (0 never expires), a non zero key replaces a queued
+    // uplink with the same key.
+    bool queue(unsigned char port, uint8_t* data, int size, uint8_t priority = 0,
+               uint32_t lifetime = 0, uint16_t key = 0, bool acknowledge = false);
+    int queuedUplinks();
+    void clearUplinkQueue();
+    void setUplinkExpiredHandler(void (*fnc)(const Uplink&));
+    void setUplinkDroppedHandler(void (*fnc)(const Uplink&));
 
     void setReceiveHandler(void (*fnc)(uint8_t port, uint8_t* data, uint8_t length));
 
     void onEvent(ev_t event);
     void process();
 
+    // Run all event and receive handlers on a separate thread instead of the LMIC process thread
+    void enableDeferredCallbacks(osPriority priority = osPriorityNormal, uint32_t stackSize = DEFAULT_STACK_SIZE);
+
     void setEventHandler(void (*fnc)(ev_t));
     void setScanTimeoutEventHandler(void (*fnc)());
     void setBeaconFoundEventHandler(void (*fnc)());
@@ -74,13 +104,52 @@ public:
     void disableLinkCheck();
     void setLinkCheck(int state);
 
+    void enableLinkSupervision();
+    void disableLinkSupervision();
+    LinkSupervisor::State getLinkState();
+    LinkSupervisor& getLinkSupervisor();
+
     void setSpreadFactor(int spreadfactor);
 
+    template<class R, uint8_t DR, int8_t TxPower = R::maxTxPower>
+    void setDataRate()
+    {
+        static_assert(TxPower <= R::maxTxPower, "transmit power exceeds the region limit");
+        LMIC_setDrTxpow(Region::DataRate<R, DR>::index, TxPower);
+    }
+
     int timeUntilNextSend();
 
+    void setEnergyMonitor(EnergyMonitor* monitor);
+
+protected:
+    virtual bool canRejoin();
+    virtual void rejoin();
+
 private:
+    friend class CallbackExecutor;
+
     void init();
     void setLinkCheck();
+    int maxPayload();
+    bool fitsDataRate(int size);
+    bool sendAtDataRate(uint8_t datarate, unsigned char port, uint8_t* data, int size, bool acknowledge);
+    void restoreFrameDatarate();
+    uint32_t milliseconds();
+    void accountIdle();
+    void accountRadio(bool complete);
+    void sendQueued();
+    void releaseUplinks();
+    void deliverReleasedUplinks();
+    bool canSend();
+#if defined(CFG_eu868)
+    bool bandUsable(u1_t band);
+#endif
+    void superviseLink(LinkSupervisor::Action action);
+    bool applyLinkAction(LinkSupervisor::Action action);
+    void restoreLinkSettings();
+    void readLinkCheckAnswer();
+    void dispatchEvent(ev_t event, uint8_t port, uint8_t* data, uint8_t length);
 #ifdef RFM95_RESET_CONNECTED
     DigitalOut rfm95wReset;
 #endif
@@ -105,6 +174,37 @@ private:
 
     LogIt* log;
 
+    EnergyMonitor* energyMonitor;
+    ostime_t energyTimestamp;
+    bool radioBusy;
+    bool radioJoining;
+    uint8_t radioDatarate;
+    uint64_t radioTime;
+    Mutex energyMutex;              // send() accounts from the application thread
+
+    uint64_t clockTicks;
+    ostime_t clockTimestamp;
+    Mutex clockMutex;
+
+    UplinkScheduler uplinkScheduler;
+    Mutex uplinkMutex;
+    void (*uplinkExpiredHandler)(const Uplink&);
+    void (*uplinkDroppedHandler)(const Uplink&);
+
+    LinkSupervisor linkSupervisor;
+    bool linkSupervision;
+    int linkCheckMode;              // -1 until the application sets it
+    bool recovering;
+    bool rejoinPending;
+    bool rejoining;
+    uint8_t savedDatarate;
+    int8_t savedTxPower;
+    bool frameDatarate;             // a typed send overrides the data rate of the pending uplink
+    uint8_t frameOverride;
+    uint8_t framePrevious;
+
+    CallbackExecutor* executor;
+
     Thread* processThread;
     static void processTask(void const *argument);
 };
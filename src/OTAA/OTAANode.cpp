@@ -66,6 +66,17 @@ Node::~Node()
 
 }
 
+bool Node::canRejoin()
+{
+    return true;
+}
+
+void Node::rejoin()
+{
+    LMIC_reset();
+    LMIC_startJoining();
+}
+
 }
 
 }
\ No newline at end of file
@@ -36,6 +36,10 @@ class Node : public SimpleLoRaWAN::Node
 public:
     Node(uint8_t _app_eui[], uint8_t _dev_eui[], uint8_t _app_key[]);
     virtual ~Node();
+
+protected:
+    virtual bool canRejoin();
+    virtual void rejoin();
 };
 
 }
@@ -0,0 +1,199 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIMPLE_LORAWAN_REGION_H_
+#define SIMPLE_LORAWAN_REGION_H_
+
+#include "stdint.h"
+
+// Region policies only hold constexpr functions and integral constants, so a
+// region that is never named by the application adds nothing to the image.
+
+namespace SimpleLoRaWAN
+{
+namespace Region
+{
+
+// Frame overhead around FRMPayload: MHDR(1) + FHDR(7) + FPort(1) + MIC(4)
+static const uint8_t FRAME_OVERHEAD = 13;
+
+struct EU868
+{
+    static const uint8_t dataRates = 7;            // DR0 (SF12) .. DR6 (SF7/250kHz)
+    static const int8_t maxTxPower = 14;
+    static const uint8_t channels = 16;
+    static const uint8_t defaultChannels = 3;
+
+    static constexpr uint8_t spreadingFactor(uint8_t dr)
+    {
+        return dr < 6 ? 12 - dr : 7;
+    }
+
+    static constexpr uint16_t bandwidth(uint8_t dr)
+    {
+        return dr == 6 ? 250 : 125;
+    }
+
+    static constexpr uint8_t maxPayload(uint8_t dr)
+    {
+        return dr < 3 ? 51 : dr == 3 ? 115 : 222;
+    }
+
+    // Only the default channels are fixed, others are assigned by the network (0 when unknown)
+    static constexpr uint32_t channelFrequency(uint8_t channel)
+    {
+        return channel < defaultChannels ? 868100000 + channel * 200000 : 0;
+    }
+
+    static constexpr uint16_t channelMask(uint8_t block)
+    {
+        return block == 0 ? 0x0007 : 0x0000;
+    }
+
+    // Airtime is limited to 1/divisor of the time in each sub-band (ETSI EN 300.220)
+    static constexpr uint16_t dutyCycleDivisor(uint32_t frequency)
+    {
+        return frequency >= 869400000 && frequency <= 869650000 ? 10
+             : frequency >= 868000000 && frequency <= 868600000 ? 100
+             : frequency >= 869700000 && frequency <= 870000000 ? 100
+             : 1000;
+    }
+};
+
+struct US915
+{
+    static const uint8_t dataRates = 5;            // DR0 (SF10) .. DR4 (SF8/500kHz)
+    static const int8_t maxTxPower = 20;           // SX1276 PA_BOOST limit, FCC allows 30 dBm
+    static const uint8_t channels = 72;
+    static const uint8_t defaultChannels = 72;
+
+    static constexpr uint8_t spreadingFactor(uint8_t dr)
+    {
+        return dr < 4 ? 10 - dr : 8;
+    }
+
+    static constexpr uint16_t bandwidth(uint8_t dr)
+    {
+        return dr == 4 ? 500 : 125;
+    }
+
+    static constexpr uint8_t maxPayload(uint8_t dr)
+    {
+        return dr == 0 ? 11 : dr == 1 ? 53 : dr == 2 ? 125 : 242;
+    }
+
+    static constexpr uint32_t channelFrequency(uint8_t channel)
+    {
+        return channel < 64 ? 902300000 + channel * 200000
+                            : 903000000 + (channel - 64) * 1600000;
+    }
+
+    static constexpr uint16_t channelMask(uint8_t block)
+    {
+        return block < 4 ? 0xFFFF : block == 4 ? 0x00FF : 0x0000;
+    }
+
+    // FCC part 15 limits dwell time instead of duty cycle
+    static constexpr uint16_t dutyCycleDivisor(uint32_t)
+    {
+        return 1;
+    }
+};
+
+struct AS923
+{
+    static const uint8_t dataRates = 7;            // DR0 (SF12) .. DR6 (SF7/250kHz)
+    static const int8_t maxTxPower = 16;
+    static const uint8_t channels = 16;
+    static const uint8_t defaultChannels = 2;
+
+    static constexpr uint8_t spreadingFactor(uint8_t dr)
+    {
+        return dr < 6 ? 12 - dr : 7;
+    }
+
+    static constexpr uint16_t bandwidth(uint8_t dr)
+    {
+        return dr == 6 ? 250 : 125;
+    }
+
+    // UplinkDwellTime = 0
+    static constexpr uint8_t maxPayload(uint8_t dr)
+    {
+        return dr < 3 ? 51 : dr == 3 ? 115 : 242;
+    }
+
+    // Only the default channels are fixed, others are assigned by the network (0 when unknown)
+    static constexpr uint32_t channelFrequency(uint8_t channel)
+    {
+        return channel < defaultChannels ? 923200000 + channel * 200000 : 0;
+    }
+
+    static constexpr uint16_t channelMask(uint8_t block)
+    {
+        return block == 0 ? 0x0003 : 0x0000;
+    }
+
+    static constexpr uint16_t dutyCycleDivisor(uint32_t)
+    {
+        return 100;
+    }
+};
+
+// The region the LMIC library was compiled for
+#if defined(CFG_us915)
+typedef US915 Active;
+#elif defined(CFG_as923)
+typedef AS923 Active;
+#else
+typedef EU868 Active;
+#endif
+
+template<class A, class B>
+struct IsSame
+{
+    static const bool value = false;
+};
+
+template<class A>
+struct IsSame<A, A>
+{
+    static const bool value = true;
+};
+
+template<class R, uint8_t DR>
+struct DataRate
+{
+    static_assert(IsSame<R, Active>::value, "region does not match the region LMIC is compiled for");
+    static_assert(DR < R::dataRates, "data rate is not defined for this region");
+
+    static const uint8_t index = DR;
+    static const uint8_t spreadingFactor = R::spreadingFactor(DR);
+    static const uint16_t bandwidth = R::bandwidth(DR);
+    static const uint8_t maxPayload = R::maxPayload(DR);
+};
+
+} /* namespace Region */
+} /* namespace SimpleLoRaWAN */
+
+#endif /* SIMPLE_LORAWAN_REGION_H_ */
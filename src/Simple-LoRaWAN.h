@@ -1,4 +1,9 @@
 
+#include "Region.h"
+#include "EnergyMonitor.h"
+#include "UplinkScheduler.h"
+#include "LinkSupervisor.h"
+#include "CallbackExecutor.h"
 #include "Node.h"
 #include "OTAANode.h"
 #include "ABPNode.h"
\ No newline at end of file
@@ -0,0 +1,213 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "UplinkScheduler.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace SimpleLoRaWAN
+{
+
+UplinkScheduler::UplinkScheduler()
+{
+    sequence = 0;
+    releasedHead = 0;
+    releasedCount = 0;
+    clear();
+}
+
+bool UplinkScheduler::push(uint8_t port, const uint8_t* data, int size, uint32_t now,
+                           uint8_t priority, uint32_t lifetime, uint16_t key, bool acknowledge)
+{
+    if(size < 0 || size > SIMPLE_LORAWAN_UPLINK_MAX_PAYLOAD) {
+        return false;
+    }
+
+    expire(now);
+
+    // a newer reading from the same source replaces the queued one
+    int slot = (key != 0) ? find(key) : -1;
+    if(slot < 0) {
+        slot = freeSlot();
+    }
+    if(slot < 0) {
+        slot = lowest();
+        if(entries[slot].priority >= priority) {
+            return false;
+        }
+        release(slot, DROPPED);
+    }
+
+    Uplink& uplink = entries[slot];
+    uplink.port = port;
+    memcpy(uplink.data, data, size);
+    uplink.size = size;
+    uplink.acknowledge = acknowledge;
+    uplink.priority = priority;
+    uplink.key = key;
+    uplink.expires = (lifetime != 0);
+    uplink.deadline = now + lifetime;
+    uplink.sequence = sequence++;
+    used[slot] = true;
+    return true;
+}
+
+// Highest priority first, oldest first within the same priority. Uplinks larger
+// than maxSize stay queued until they fit or expire.
+bool UplinkScheduler::pop(Uplink& uplink, uint32_t now, int maxSize)
+{
+    expire(now);
+
+    int best = -1;
+    for(int i = 0; i < SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE; i++) {
+        if(!used[i] || entries[i].size > maxSize) {
+            continue;
+        }
+        if(best < 0
+           || entries[i].priority > entries[best].priority
+           || (entries[i].priority == entries[best].priority
+               && (int32_t)(entries[i].sequence - entries[best].sequence) < 0)) {
+            best = i;
+        }
+    }
+    if(best < 0) {
+        return false;
+    }
+
+    uplink = entries[best];
+    used[best] = false;
+    return true;
+}
+
+int UplinkScheduler::expire(uint32_t now)
+{
+    int count = 0;
+    for(int i = 0; i < SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE; i++) {
+        if(used[i] && isExpired(entries[i], now)) {
+            release(i, EXPIRED);
+            count++;
+        }
+    }
+    return count;
+}
+
+void UplinkScheduler::clear()
+{
+    for(int i = 0; i < SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE; i++) {
+        used[i] = false;
+    }
+}
+
+int UplinkScheduler::size() const
+{
+    int count = 0;
+    for(int i = 0; i < SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE; i++) {
+        if(used[i]) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool UplinkScheduler::isEmpty() const
+{
+    return size() == 0;
+}
+
+// Oldest release first
+bool UplinkScheduler::takeReleased(Uplink& uplink, Release& reason)
+{
+    if(releasedCount == 0) {
+        return false;
+    }
+    uplink = released[releasedHead];
+    reason = reasons[releasedHead];
+    releasedHead = (releasedHead + 1) % SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE;
+    releasedCount--;
+    return true;
+}
+
+bool UplinkScheduler::hasReleased() const
+{
+    return releasedCount > 0;
+}
+
+int UplinkScheduler::find(uint16_t key) const
+{
+    for(int i = 0; i < SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE; i++) {
+        if(used[i] && entries[i].key == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int UplinkScheduler::freeSlot() const
+{
+    for(int i = 0; i < SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE; i++) {
+        if(!used[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Lowest priority, oldest (stalest) first within the same priority
+int UplinkScheduler::lowest() const
+{
+    int worst = -1;
+    for(int i = 0; i < SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE; i++) {
+        if(!used[i]) {
+            continue;
+        }
+        if(worst < 0
+           || entries[i].priority < entries[worst].priority
+           || (entries[i].priority == entries[worst].priority
+               && (int32_t)(entries[i].sequence - entries[worst].sequence) < 0)) {
+            worst = i;
+        }
+    }
+    return worst;
+}
+
+// When nobody collects the released uplinks, the oldest one is forgotten
+void UplinkScheduler::release(int slot, Release reason)
+{
+    used[slot] = false;
+    if(releasedCount == SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE) {
+        releasedHead = (releasedHead + 1) % SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE;
+        releasedCount--;
+    }
+    int index = (releasedHead + releasedCount) % SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE;
+    released[index] = entries[slot];
+    reasons[index] = reason;
+    releasedCount++;
+}
+
+bool UplinkScheduler::isExpired(const Uplink& uplink, uint32_t now) const
+{
+    return uplink.expires && (int32_t)(now - uplink.deadline) >= 0;
+}
+
+} /* namespace SimpleLoRaWAN */
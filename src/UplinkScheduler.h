@@ -0,0 +1,98 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIMPLE_LORAWAN_UPLINK_SCHEDULER_H_
+#define SIMPLE_LORAWAN_UPLINK_SCHEDULER_H_
+
+#include "stdint.h"
+
+#ifndef SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE
+#define SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE 8
+#endif
+
+#ifndef SIMPLE_LORAWAN_UPLINK_MAX_PAYLOAD
+#define SIMPLE_LORAWAN_UPLINK_MAX_PAYLOAD 51
+#endif
+
+namespace SimpleLoRaWAN
+{
+
+struct Uplink
+{
+    uint8_t port;
+    uint8_t data[SIMPLE_LORAWAN_UPLINK_MAX_PAYLOAD];
+    uint8_t size;
+    bool acknowledge;
+    uint8_t priority;       // higher is more urgent
+    uint16_t key;           // source key, 0 when the uplink never replaces another
+    bool expires;
+    uint32_t deadline;      // milliseconds, only valid when expires is set
+    uint32_t sequence;
+};
+
+// Fixed size priority queue of pending uplinks. Times are in milliseconds
+// from any free running clock, wrap around is handled.
+// Expired and dropped uplinks are kept aside until takeReleased() picks them up,
+// so their handlers can run outside whatever lock guards the queue.
+class UplinkScheduler
+{
+public:
+    enum Release {
+        EXPIRED = 0,
+        DROPPED
+    };
+
+    UplinkScheduler();
+
+    bool push(uint8_t port, const uint8_t* data, int size, uint32_t now,
+              uint8_t priority = 0, uint32_t lifetime = 0, uint16_t key = 0, bool acknowledge = false);
+    bool pop(Uplink& uplink, uint32_t now, int maxSize = SIMPLE_LORAWAN_UPLINK_MAX_PAYLOAD);
+    int expire(uint32_t now);
+    void clear();
+
+    int size() const;
+    bool isEmpty() const;
+
+    bool takeReleased(Uplink& uplink, Release& reason);
+    bool hasReleased() const;
+
+private:
+    int find(uint16_t key) const;
+    int freeSlot() const;
+    int lowest() const;
+    bool isExpired(const Uplink& uplink, uint32_t now) const;
+    void release(int slot, Release reason);
+
+    Uplink entries[SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE];
+    bool used[SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE];
+    uint32_t sequence;
+
+    Uplink released[SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE];
+    Release reasons[SIMPLE_LORAWAN_UPLINK_QUEUE_SIZE];
+    int releasedHead;
+    int releasedCount;
+};
+
+} /* namespace SimpleLoRaWAN */
+
+#endif /* SIMPLE_LORAWAN_UPLINK_SCHEDULER_H_ */
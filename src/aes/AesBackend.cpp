@@ -0,0 +1,149 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "AesBackend.h"
+
+#if SIMPLE_LORAWAN_AES_BACKEND != SIMPLE_LORAWAN_AES_LMIC
+
+#include "lmic.h"
+#include <string.h>
+
+// Key and IV buffers LMIC writes to through AESkey and AESaux
+u4_t AESAUX[16/sizeof(u4_t)];
+u4_t AESKEY[11*16/sizeof(u4_t)];
+
+// CMAC subkey doubling in GF(2^128), without data dependent branches
+static void doubleBlock(uint8_t block[16])
+{
+    uint8_t carry = block[0] >> 7;
+    for(int i = 0; i < 15; i++) {
+        block[i] = (block[i] << 1) | (block[i + 1] >> 7);
+    }
+    block[15] = (block[15] << 1) ^ ((uint8_t)-carry & 0x87);
+}
+
+static void xorBlock(uint8_t* block, const uint8_t* data, int length)
+{
+    for(int i = 0; i < length; i++) {
+        block[i] ^= data[i];
+    }
+}
+
+// The CMAC subkey only depends on the key. Uplink MICs all use the NwkSKey,
+// so the one for the last key is kept; the key comparison does not stop at
+// the first difference.
+static uint8_t subkeyKey[16];
+static uint8_t subkeyCache[16];
+static bool subkeyValid = false;
+
+static void firstSubkey(uint8_t subkey[16])
+{
+    uint8_t diff = subkeyValid ? 0 : 1;
+    for(int i = 0; i < 16; i++) {
+        diff |= subkeyKey[i] ^ AESkey[i];
+    }
+    if(diff != 0) {
+        memset(subkeyCache, 0, 16);
+        aes_backend_encrypt(subkeyCache, 1);
+        doubleBlock(subkeyCache);
+        memcpy(subkeyKey, AESkey, 16);
+        subkeyValid = true;
+    }
+    memcpy(subkey, subkeyCache, 16);
+}
+
+// AES-CMAC (RFC 4493) over the B0 block in AESaux followed by buf,
+// or over buf alone for AES_MICNOAUX. Returns the first four bytes MSB first.
+static u4_t mic(u1_t mode, const uint8_t* buf, int length)
+{
+    uint8_t x[16];
+    uint8_t subkey[16];
+
+    firstSubkey(subkey);
+
+    memset(x, 0, 16);
+    if((mode & AES_MICNOAUX) == 0) {
+        xorBlock(x, AESaux, 16);
+        aes_backend_encrypt(x, 1);
+    }
+
+    while(length > 16) {
+        xorBlock(x, buf, 16);
+        aes_backend_encrypt(x, 1);
+        buf += 16;
+        length -= 16;
+    }
+
+    xorBlock(x, buf, length);
+    if(length < 16) {
+        x[length] ^= 0x80;
+        doubleBlock(subkey);
+    }
+    xorBlock(x, subkey, 16);
+    aes_backend_encrypt(x, 1);
+
+    return ((u4_t)x[0] << 24) | ((u4_t)x[1] << 16) | ((u4_t)x[2] << 8) | x[3];
+}
+
+// Counter mode with the initial counter block in AESaux, the last four bytes count.
+// The key stream of a whole frame payload is encrypted in one call.
+static void ctr(uint8_t* buf, int length)
+{
+    static const int STREAM_BLOCKS = 4;
+    uint8_t counter[16];
+    uint8_t stream[16 * STREAM_BLOCKS];
+
+    memcpy(counter, AESaux, 16);
+    while(length > 0) {
+        int blocks = 0;
+        while(blocks < STREAM_BLOCKS && 16 * blocks < length) {
+            memcpy(stream + 16 * blocks, counter, 16);
+            for(int i = 15; i >= 12 && ++counter[i] == 0; i--);
+            blocks++;
+        }
+        aes_backend_encrypt(stream, blocks);
+
+        int used = length < 16 * blocks ? length : 16 * blocks;
+        xorBlock(buf, stream, used);
+        buf += used;
+        length -= used;
+    }
+}
+
+u4_t os_aes(u1_t mode, xref2u1_t buf, u2_t len)
+{
+    aes_backend_set_key(AESkey);
+
+    if(mode & AES_MIC) {
+        return mic(mode, buf, len);
+    }
+    if(mode & AES_CTR) {
+        ctr(buf, len);
+        return 0;
+    }
+    aes_backend_encrypt(buf, len / 16);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIMPLE_LORAWAN_AES_BACKEND_H_
+#define SIMPLE_LORAWAN_AES_BACKEND_H_
+
+#include "stdint.h"
+
+// AES implementation used for the MIC and payload encryption of every frame.
+//
+//  SIMPLE_LORAWAN_AES_LMIC      the software AES bundled with LMIC (default)
+//  SIMPLE_LORAWAN_AES_SOFTWARE  constant time (bitsliced) AES-128 from aes/SoftwareAes.cpp
+//  SIMPLE_LORAWAN_AES_HARDWARE  the application implements aes_backend_set_key()
+//                               and aes_backend_encrypt() on the MCU crypto peripheral
+//
+// Any backend other than LMIC provides os_aes(), AESKEY and AESAUX itself, so
+// aes.c of the LMIC library has to be excluded from the build (.mbedignore).
+
+#define SIMPLE_LORAWAN_AES_LMIC     0
+#define SIMPLE_LORAWAN_AES_SOFTWARE 1
+#define SIMPLE_LORAWAN_AES_HARDWARE 2
+
+#ifndef SIMPLE_LORAWAN_AES_BACKEND
+#define SIMPLE_LORAWAN_AES_BACKEND SIMPLE_LORAWAN_AES_LMIC
+#endif
+
+#if SIMPLE_LORAWAN_AES_BACKEND != SIMPLE_LORAWAN_AES_LMIC
+
+// Called before every operation, the key is usually the same as the previous call
+void aes_backend_set_key(const uint8_t key[16]);
+
+// Encrypts count consecutive 16 byte blocks in place (ECB) with the last key set
+void aes_backend_encrypt(uint8_t* blocks, int count);
+
+#endif
+
+#endif /* SIMPLE_LORAWAN_AES_BACKEND_H_ */
@@ -0,0 +1,424 @@
+/* The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Sille Van Landschoot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "AesBackend.h"
+
+#if SIMPLE_LORAWAN_AES_BACKEND == SIMPLE_LORAWAN_AES_SOFTWARE
+
+#include <string.h>
+
+// Constant time AES-128 encryption, without lookup tables indexed by key or data.
+//
+// The portable version is bitsliced: two blocks are transposed into 8 words,
+// word b holding bit b of every state byte, and each round is a fixed sequence
+// of logic operations (the Boyar-Peralta S-box circuit, shifts and rotations).
+// Counter mode fills both halves, CMAC only one. On x86 hosts with the AES
+// instructions, which are constant time by design, those are used instead,
+// unless SIMPLE_LORAWAN_AES_PORTABLE is defined.
+//
+// Round keys are cached for the two most recent keys, so alternating NwkSKey
+// and AppSKey never repeats the key schedule; the key comparison does not
+// stop at the first difference.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SIMPLE_LORAWAN_AES_PORTABLE)
+#define SIMPLE_LORAWAN_AES_NI 1
+#include <wmmintrin.h>
+#endif
+
+typedef uint32_t Planes[8];
+
+struct ExpandedKey
+{
+    uint8_t key[16];
+    Planes roundKeys[11];
+    uint8_t roundKeyBytes[11][16];
+    bool valid;
+};
+
+static ExpandedKey keys[2];
+static ExpandedKey* current = &keys[0];
+
+static const uint8_t RCON[10] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+};
+
+static void subBytes(Planes q)
+{
+    uint32_t x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+    uint32_t x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // top linear transformation
+    uint32_t y14 = x3 ^ x5;
+    uint32_t y13 = x0 ^ x6;
+    uint32_t y9 = x0 ^ x3;
+    uint32_t y8 = x0 ^ x5;
+    uint32_t t0 = x1 ^ x2;
+    uint32_t y1 = t0 ^ x7;
+    uint32_t y4 = y1 ^ x3;
+    uint32_t y12 = y13 ^ y14;
+    uint32_t y2 = y1 ^ x0;
+    uint32_t y5 = y1 ^ x6;
+    uint32_t y3 = y5 ^ y8;
+    uint32_t t1 = x4 ^ y12;
+    uint32_t y15 = t1 ^ x5;
+    uint32_t y20 = t1 ^ x1;
+    uint32_t y6 = y15 ^ x7;
+    uint32_t y10 = y15 ^ t0;
+    uint32_t y11 = y20 ^ y9;
+    uint32_t y7 = x7 ^ y11;
+    uint32_t y17 = y10 ^ y11;
+    uint32_t y19 = y10 ^ y8;
+    uint32_t y16 = t0 ^ y11;
+    uint32_t y21 = y13 ^ y16;
+    uint32_t y18 = x0 ^ y16;
+
+    // inversion in GF(2^8)
+    uint32_t t2 = y12 & y15;
+    uint32_t t3 = y3 & y6;
+    uint32_t t4 = t3 ^ t2;
+    uint32_t t5 = y4 & x7;
+    uint32_t t6 = t5 ^ t2;
+    uint32_t t7 = y13 & y16;
+    uint32_t t8 = y5 & y1;
+    uint32_t t9 = t8 ^ t7;
+    uint32_t t10 = y2 & y7;
+    uint32_t t11 = t10 ^ t7;
+    uint32_t t12 = y9 & y11;
+    uint32_t t13 = y14 & y17;
+    uint32_t t14 = t13 ^ t12;
+    uint32_t t15 = y8 & y10;
+    uint32_t t16 = t15 ^ t12;
+    uint32_t t17 = t4 ^ t14;
+    uint32_t t18 = t6 ^ t16;
+    uint32_t t19 = t9 ^ t14;
+    uint32_t t20 = t11 ^ t16;
+    uint32_t t21 = t17 ^ y20;
+    uint32_t t22 = t18 ^ y19;
+    uint32_t t23 = t19 ^ y21;
+    uint32_t t24 = t20 ^ y18;
+
+    uint32_t t25 = t21 ^ t22;
+    uint32_t t26 = t21 & t23;
+    uint32_t t27 = t24 ^ t26;
+    uint32_t t28 = t25 & t27;
+    uint32_t t29 = t28 ^ t22;
+    uint32_t t30 = t23 ^ t24;
+    uint32_t t31 = t22 ^ t26;
+    uint32_t t32 = t31 & t30;
+    uint32_t t33 = t32 ^ t24;
+    uint32_t t34 = t23 ^ t33;
+    uint32_t t35 = t27 ^ t33;
+    uint32_t t36 = t24 & t35;
+    uint32_t t37 = t36 ^ t34;
+    uint32_t t38 = t27 ^ t36;
+    uint32_t t39 = t29 & t38;
+    uint32_t t40 = t25 ^ t39;
+
+    uint32_t t41 = t40 ^ t37;
+    uint32_t t42 = t29 ^ t33;
+    uint32_t t43 = t29 ^ t40;
+    uint32_t t44 = t33 ^ t37;
+    uint32_t t45 = t42 ^ t41;
+    uint32_t z0 = t44 & y15;
+    uint32_t z1 = t37 & y6;
+    uint32_t z2 = t33 & x7;
+    uint32_t z3 = t43 & y16;
+    uint32_t z4 = t40 & y1;
+    uint32_t z5 = t29 & y7;
+    uint32_t z6 = t42 & y11;
+    uint32_t z7 = t45 & y17;
+    uint32_t z8 = t41 & y10;
+    uint32_t z9 = t44 & y12;
+    uint32_t z10 = t37 & y3;
+    uint32_t z11 = t33 & y4;
+    uint32_t z12 = t43 & y13;
+    uint32_t z13 = t40 & y5;
+    uint32_t z14 = t29 & y2;
+    uint32_t z15 = t42 & y9;
+    uint32_t z16 = t45 & y14;
+    uint32_t z17 = t41 & y8;
+
+    // bottom linear transformation
+    uint32_t t46 = z15 ^ z16;
+    uint32_t t47 = z10 ^ z11;
+    uint32_t t48 = z5 ^ z13;
+    uint32_t t49 = z9 ^ z10;
+    uint32_t t50 = z2 ^ z12;
+    uint32_t t51 = z2 ^ z5;
+    uint32_t t52 = z7 ^ z8;
+    uint32_t t53 = z0 ^ z3;
+    uint32_t t54 = z6 ^ z7;
+    uint32_t t55 = z16 ^ z17;
+    uint32_t t56 = z12 ^ t48;
+    uint32_t t57 = t50 ^ t53;
+    uint32_t t58 = z4 ^ t46;
+    uint32_t t59 = z3 ^ t54;
+    uint32_t t60 = t46 ^ t57;
+    uint32_t t61 = z14 ^ t57;
+    uint32_t t62 = t52 ^ t58;
+    uint32_t t63 = t49 ^ t58;
+    uint32_t t64 = z4 ^ t59;
+    uint32_t t65 = t61 ^ t62;
+    uint32_t t66 = z1 ^ t63;
+    uint32_t t67 = t64 ^ t65;
+
+    uint32_t s0 = t59 ^ t63;
+    uint32_t s6 = t56 ^ ~t62;
+    uint32_t s7 = t48 ^ ~t60;
+    uint32_t s3 = t53 ^ t66;
+    uint32_t s4 = t51 ^ t66;
+    uint32_t s5 = t47 ^ t65;
+    uint32_t s1 = t64 ^ ~s3;
+    uint32_t s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+static inline void swapBits(uint32_t& x, uint32_t& y, uint32_t mask, int shift)
+{
+    uint32_t a = x;
+    uint32_t b = y;
+    x = (a & mask) | ((b & mask) << shift);
+    y = ((a >> shift) & mask) | (b & ~mask);
+}
+
+// Transposes between 8 words of two interleaved blocks and 8 bit planes,
+// the transform is its own inverse
+static void ortho(Planes q)
+{
+    swapBits(q[0], q[1], 0x55555555, 1);
+    swapBits(q[2], q[3], 0x55555555, 1);
+    swapBits(q[4], q[5], 0x55555555, 1);
+    swapBits(q[6], q[7], 0x55555555, 1);
+
+    swapBits(q[0], q[2], 0x33333333, 2);
+    swapBits(q[1], q[3], 0x33333333, 2);
+    swapBits(q[4], q[6], 0x33333333, 2);
+    swapBits(q[5], q[7], 0x33333333, 2);
+
+    swapBits(q[0], q[4], 0x0f0f0f0f, 4);
+    swapBits(q[1], q[5], 0x0f0f0f0f, 4);
+    swapBits(q[2], q[6], 0x0f0f0f0f, 4);
+    swapBits(q[3], q[7], 0x0f0f0f0f, 4);
+}
+
+// In the bitsliced layout every row of the state is one byte of a plane
+static void shiftRows(Planes q)
+{
+    for(int b = 0; b < 8; b++) {
+        uint32_t x = q[b];
+        q[b] = (x & 0x000000ff)
+             | ((x & 0x0000fc00) >> 2) | ((x & 0x00000300) << 6)
+             | ((x & 0x00f00000) >> 4) | ((x & 0x000f0000) << 4)
+             | ((x & 0xc0000000) >> 6) | ((x & 0x3f000000) << 2);
+    }
+}
+
+static inline uint32_t rotate(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static void mixColumns(Planes q)
+{
+    uint32_t r[8];
+    uint32_t s[8];
+    for(int b = 0; b < 8; b++) {
+        r[b] = rotate(q[b], 8);
+        s[b] = q[b] ^ r[b];
+    }
+    q[0] = s[7] ^ r[0] ^ rotate(s[0], 16);
+    q[1] = s[0] ^ s[7] ^ r[1] ^ rotate(s[1], 16);
+    q[2] = s[1] ^ r[2] ^ rotate(s[2], 16);
+    q[3] = s[2] ^ s[7] ^ r[3] ^ rotate(s[3], 16);
+    q[4] = s[3] ^ s[7] ^ r[4] ^ rotate(s[4], 16);
+    q[5] = s[4] ^ r[5] ^ rotate(s[5], 16);
+    q[6] = s[5] ^ r[6] ^ rotate(s[6], 16);
+    q[7] = s[6] ^ r[7] ^ rotate(s[7], 16);
+}
+
+static inline void addRoundKey(Planes q, const Planes key)
+{
+    for(int b = 0; b < 8; b++) {
+        q[b] ^= key[b];
+    }
+}
+
+static inline uint32_t load32le(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32le(uint8_t* p, uint32_t x)
+{
+    p[0] = x;
+    p[1] = x >> 8;
+    p[2] = x >> 16;
+    p[3] = x >> 24;
+}
+
+static uint32_t subWord(uint32_t x)
+{
+    Planes q;
+    memset(q, 0, sizeof(q));
+    q[0] = x;
+    ortho(q);
+    subBytes(q);
+    ortho(q);
+    return q[0];
+}
+
+static void expandKey(ExpandedKey* expanded, const uint8_t key[16])
+{
+    uint32_t w[44];
+    for(int i = 0; i < 4; i++) {
+        w[i] = load32le(key + 4 * i);
+    }
+    for(int i = 4; i < 44; i++) {
+        uint32_t t = w[i - 1];
+        if((i & 3) == 0) {
+            t = subWord(rotate(t, 8)) ^ RCON[i / 4 - 1];
+        }
+        w[i] = w[i - 4] ^ t;
+    }
+
+    for(int round = 0; round < 11; round++) {
+        Planes& q = expanded->roundKeys[round];
+        for(int i = 0; i < 4; i++) {
+            q[2 * i] = w[4 * round + i];
+            q[2 * i + 1] = w[4 * round + i];
+            store32le(expanded->roundKeyBytes[round] + 4 * i, w[4 * round + i]);
+        }
+        ortho(q);
+    }
+    memcpy(expanded->key, key, 16);
+    expanded->valid = true;
+}
+
+static bool sameKey(const uint8_t a[16], const uint8_t b[16])
+{
+    uint8_t diff = 0;
+    for(int i = 0; i < 16; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+void aes_backend_set_key(const uint8_t key[16])
+{
+    if(current->valid && sameKey(current->key, key)) {
+        return;
+    }
+    ExpandedKey* other = (current == &keys[0]) ? &keys[1] : &keys[0];
+    if(!other->valid || !sameKey(other->key, key)) {
+        expandKey(other, key);
+    }
+    current = other;
+}
+
+// One or two blocks, the second one may be NULL
+static void encryptBitsliced(uint8_t* first, uint8_t* second)
+{
+    const Planes* rk = current->roundKeys;
+    Planes q;
+
+    for(int i = 0; i < 4; i++) {
+        q[2 * i] = load32le(first + 4 * i);
+        q[2 * i + 1] = (second != NULL) ? load32le(second + 4 * i) : 0;
+    }
+    ortho(q);
+
+    addRoundKey(q, rk[0]);
+    for(int round = 1; round < 10; round++) {
+        subBytes(q);
+        shiftRows(q);
+        mixColumns(q);
+        addRoundKey(q, rk[round]);
+    }
+    subBytes(q);
+    shiftRows(q);
+    addRoundKey(q, rk[10]);
+
+    ortho(q);
+    for(int i = 0; i < 4; i++) {
+        store32le(first + 4 * i, q[2 * i]);
+        if(second != NULL) {
+            store32le(second + 4 * i, q[2 * i + 1]);
+        }
+    }
+}
+
+#ifdef SIMPLE_LORAWAN_AES_NI
+
+__attribute__((target("aes,sse2")))
+static void encryptInstructions(uint8_t* blocks, int count)
+{
+    __m128i rk[11];
+    for(int round = 0; round < 11; round++) {
+        rk[round] = _mm_loadu_si128((const __m128i*)current->roundKeyBytes[round]);
+    }
+    for(int i = 0; i < count; i++) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(blocks + 16 * i)), rk[0]);
+        for(int round = 1; round < 10; round++) {
+            x = _mm_aesenc_si128(x, rk[round]);
+        }
+        x = _mm_aesenclast_si128(x, rk[10]);
+        _mm_storeu_si128((__m128i*)(blocks + 16 * i), x);
+    }
+}
+
+static bool hasInstructions()
+{
+    static int supported = -1;
+    if(supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("aes") ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+#endif
+
+void aes_backend_encrypt(uint8_t* blocks, int count)
+{
+#ifdef SIMPLE_LORAWAN_AES_NI
+    if(hasInstructions()) {
+        encryptInstructions(blocks, count);
+        return;
+    }
+#endif
+    for( ; count >= 2; count -= 2, blocks += 32) {
+        encryptBitsliced(blocks, blocks + 16);
+    }
+    if(count == 1) {
+        encryptBitsliced(blocks, NULL);
+    }
+}
+
+#endif